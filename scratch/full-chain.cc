@@ -0,0 +1,271 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+//
+// Multi-hop relay chain with full duplex forwarding.
+//
+// Topology: [node 0] -- d -- [node 1] -- d -- ... -- [node N-1]
+//
+// A CBR stream is sent from node 0 to node N-1. Every intermediate node
+// relays towards its right neighbour through a static host route. In full
+// duplex mode every relay gets a ForwardQueue mapping its left neighbour to
+// its right one, so with EnableForward it can send to the next hop while it
+// still receives from the previous one (A -> B e B -> C). The end-to-end throughput and
+// delay of the chain, and of every single hop, are reported at the end of
+// the run, so chains of different length and both duplex modes can be
+// compared:
+//
+// ./waf --run "full-chain --numNodes=4 --fullDuplex=1"
+// ./waf --run "full-chain --numNodes=4 --fullDuplex=0"
+//
+
+#include "ns3/core-module.h"
+#include "ns3/propagation-module.h"
+#include "ns3/network-module.h"
+#include "ns3/applications-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/flow-monitor-module.h"
+#include "ns3/full-module.h"
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdlib>
+
+NS_LOG_COMPONENT_DEFINE ("FullChain");
+
+using namespace ns3;
+
+/// per hop counters, indexed by the transmitting node of the hop
+std::vector<uint32_t> hopRxPackets;
+std::vector<uint64_t> hopRxBytes;
+uint16_t cbrPort = 12345;
+
+uint32_t
+GetNodeIdFromContext (std::string context)
+{
+  // context is "/NodeList/<id>/DeviceList/..."
+  std::string::size_type start = context.find ("/NodeList/") + 10;
+  std::string::size_type end = context.find ("/", start);
+  return std::atoi (context.substr (start, end - start).c_str ());
+}
+
+/// Count the CBR packets a node's IP layer receives. They only travel
+/// towards the sink, so they always come from the left neighbour; ARP, the
+/// echo warm-up and its reply are skipped. The packet still starts with
+/// its IPv4 header here, whatever the device stripped below it.
+void IpRx (std::string context, Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface)
+{
+  uint32_t nodeId = GetNodeIdFromContext (context);
+  if (nodeId == 0)
+    {
+      return;
+    }
+  Ptr<Packet> copy = packet->Copy ();
+  Ipv4Header ip;
+  copy->RemoveHeader (ip);
+  if (ip.GetProtocol () != UdpL4Protocol::PROT_NUMBER)
+    {
+      return;
+    }
+  UdpHeader udp;
+  copy->PeekHeader (udp);
+  if (udp.GetDestinationPort () != cbrPort)
+    {
+      return;
+    }
+  hopRxPackets[nodeId - 1]++;
+  hopRxBytes[nodeId - 1] += packet->GetSize ();
+}
+
+/// Let every relay forward from its left neighbour to its right one
+void SetChainForwardQueues (NetDeviceContainer devices)
+{
+  for (uint32_t i = 1; i + 1 < devices.GetN (); ++i)
+    {
+      Ptr<ForwardQueue> queue = CreateObject<ForwardQueue> ();
+      ForwardMap cmap (Mac48Address::ConvertFrom (devices.Get (i - 1)->GetAddress ()));
+      cmap.AddItem (ForwardItem (Mac48Address::ConvertFrom (devices.Get (i + 1)->GetAddress ()), 1));
+      queue->AddForwardMap (cmap);
+      Ptr<FullWifiNetDevice> device = Ptr<FullWifiNetDevice>(dynamic_cast<FullWifiNetDevice*> (
+          ns3::PeekPointer (devices.Get (i))));
+      Ptr<FullRegularWifiMac> mac = Ptr<FullRegularWifiMac>(dynamic_cast<FullRegularWifiMac*>(
+          ns3::PeekPointer (device->GetMac ())));
+      NS_ABORT_MSG_IF (mac == 0, "relay " << i << " has no FullRegularWifiMac");
+      mac->SetForwardQueue (queue);
+    }
+}
+
+int main (int argc, char **argv)
+{
+  uint32_t numNodes = 4;
+  double distance = 80;   // m
+  uint32_t packetSize = 1000;   // bytes
+  std::string phyMode ("OfdmRate54Mbps");
+  std::string dataRate ("54000000bps");
+  double startTime = 1;
+  double stopTime = 3;
+  bool fullDuplex = true;
+
+  CommandLine cmd;
+  cmd.AddValue ("numNodes", "number of nodes in the chain", numNodes);
+  cmd.AddValue ("distance", "distance between neighbours (m)", distance);
+  cmd.AddValue ("packetSize", "size of application packet sent", packetSize);
+  cmd.AddValue ("phyMode", "Wifi Phy mode", phyMode);
+  cmd.AddValue ("dataRate", "offered load of the CBR stream", dataRate);
+  cmd.AddValue ("startTime", "start time", startTime);
+  cmd.AddValue ("stopTime", "stop time", stopTime);
+  cmd.AddValue ("fullDuplex", "enable full duplex forwarding (true) or half duplex (false)", fullDuplex);
+  cmd.Parse (argc, argv);
+
+  NS_ABORT_MSG_IF (numNodes < 2, "the chain needs at least 2 nodes, got " << numNodes);
+
+  // disable fragmentation and RTS/CTS for frames below 2200 bytes
+  Config::SetDefault ("ns3::FullWifiRemoteStationManager::FragmentationThreshold", StringValue ("2200"));
+  Config::SetDefault ("ns3::FullWifiRemoteStationManager::RtsCtsThreshold", StringValue ("2200"));
+  Config::SetDefault ("ns3::FullWifiRemoteStationManager::NonUnicastMode", StringValue (phyMode));
+
+  NodeContainer nodes;
+  nodes.Create (numNodes);
+  hopRxPackets.assign (numNodes, 0);
+  hopRxBytes.assign (numNodes, 0);
+
+  MobilityHelper mobility;
+  Ptr<ListPositionAllocator> positionAlloc = CreateObject<ListPositionAllocator> ();
+  for (uint32_t i = 0; i < numNodes; ++i)
+    {
+      positionAlloc->Add (Vector (i * distance, 0.0, 0.0));
+    }
+  mobility.SetPositionAllocator (positionAlloc);
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobility.Install (nodes);
+
+  Ptr<FriisPropagationLossModel> lossModel = CreateObject<FriisPropagationLossModel> ();
+  lossModel->SetLambda (3.0e8/5.0e9);
+
+  Ptr<FullYansWifiChannel> wifiChannel = CreateObject <FullYansWifiChannel> ();
+  wifiChannel->SetPropagationLossModel (lossModel);
+  wifiChannel->SetPropagationDelayModel (CreateObject <ConstantSpeedPropagationDelayModel> ());
+
+  FullWifiHelper wifi;
+  wifi.SetStandard (FULL_WIFI_PHY_STANDARD_80211a);
+  wifi.SetRemoteStationManager ("ns3::FullConstantRateWifiManager",
+                                "DataMode",StringValue (phyMode),
+                                "ControlMode",StringValue (phyMode));
+  FullYansWifiPhyHelper wifiPhy =  FullYansWifiPhyHelper::Default ();
+  wifiPhy.SetChannel (wifiChannel);
+  wifiPhy.Set ("TxPowerStart", DoubleValue (15));
+  wifiPhy.Set ("TxPowerEnd", DoubleValue (15));
+  wifiPhy.Set ("RxNoiseFigure", DoubleValue (7));
+  wifiPhy.Set ("TxGain", DoubleValue (0));
+  wifiPhy.Set ("RxGain", DoubleValue (0));
+  wifiPhy.Set ("EnableCaptureEffect", BooleanValue (true));
+  wifiPhy.Set ("EnableFullDuplex", BooleanValue (fullDuplex));
+
+  FullNqosWifiMacHelper wifiMac = FullNqosWifiMacHelper::Default ();
+  wifiMac.SetType ("ns3::FullAdhocWifiMac");
+  wifiMac.Set ("EnableReturnPacket", BooleanValue (false));
+  wifiMac.Set ("EnableBusyTone", BooleanValue (false));
+  wifiMac.Set ("EnableForward", BooleanValue (fullDuplex)); //A -> B e B -> C
+  NetDeviceContainer devices = wifi.Install (wifiPhy, wifiMac, nodes);
+  if (fullDuplex)
+    {
+      SetChainForwardQueues (devices);
+    }
+
+  InternetStackHelper internet;
+  internet.Install (nodes);
+  Config::Connect ("/NodeList/*/$ns3::Ipv4L3Protocol/Rx", MakeCallback (&IpRx));
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.0.0.0", "255.0.0.0");
+  Ipv4InterfaceContainer interfaces = ipv4.Assign (devices);
+
+  // every node reaches the end of the chain through its right neighbour
+  Ipv4StaticRoutingHelper staticRouting;
+  Ipv4Address sink = interfaces.GetAddress (numNodes - 1);
+  for (uint32_t i = 0; i + 2 < numNodes; ++i)
+    {
+      Ptr<Ipv4StaticRouting> routing = staticRouting.GetStaticRouting (nodes.Get (i)->GetObject<Ipv4> ());
+      routing->AddHostRouteTo (sink, interfaces.GetAddress (i + 1), 1);
+    }
+  // and the source back through its left neighbour, for ARP and acks
+  Ipv4Address source = interfaces.GetAddress (0);
+  for (uint32_t i = numNodes - 1; i > 1; --i)
+    {
+      Ptr<Ipv4StaticRouting> routing = staticRouting.GetStaticRouting (nodes.Get (i)->GetObject<Ipv4> ());
+      routing->AddHostRouteTo (source, interfaces.GetAddress (i - 1), 1);
+    }
+
+  OnOffHelper onOffHelper ("ns3::UdpSocketFactory", InetSocketAddress (sink, cbrPort));
+  onOffHelper.SetAttribute ("PacketSize", UintegerValue (packetSize));
+  onOffHelper.SetAttribute ("OnTime",  StringValue ("ns3::ConstantRandomVariable[Constant=1]"));
+  onOffHelper.SetAttribute ("OffTime", StringValue ("ns3::ConstantRandomVariable[Constant=0]"));
+  onOffHelper.SetAttribute ("DataRate", StringValue (dataRate));
+  onOffHelper.SetAttribute ("StartTime", TimeValue (Seconds (startTime)));
+  onOffHelper.SetAttribute ("StopTime", TimeValue (Seconds (stopTime)));
+  onOffHelper.Install (nodes.Get (0));
+
+  PacketSinkHelper sinkHelper ("ns3::UdpSocketFactory", InetSocketAddress (Ipv4Address::GetAny (), cbrPort));
+  sinkHelper.Install (nodes.Get (numNodes - 1));
+
+  // a single packet before the CBR flow starts, to resolve ARP along the
+  // chain (see Bug 187)
+  uint16_t echoPort = 9;
+  UdpEchoServerHelper echoServerHelper (echoPort);
+  echoServerHelper.Install (nodes.Get (numNodes - 1));
+  UdpEchoClientHelper echoClientHelper (sink, echoPort);
+  echoClientHelper.SetAttribute ("MaxPackets", UintegerValue (1));
+  echoClientHelper.SetAttribute ("PacketSize", UintegerValue (10));
+  echoClientHelper.SetAttribute ("StartTime", TimeValue (Seconds (0.001)));
+  echoClientHelper.Install (nodes.Get (0));
+
+  FlowMonitorHelper flowmon;
+  Ptr<FlowMonitor> monitor = flowmon.InstallAll ();
+
+  Simulator::Stop (Seconds (stopTime));
+  Simulator::Run ();
+
+  double duration = stopTime - startTime;
+  monitor->CheckForLostPackets ();
+  Ptr<Ipv4FlowClassifier> classifier = DynamicCast<Ipv4FlowClassifier> (flowmon.GetClassifier ());
+  std::map<FlowId, FlowMonitor::FlowStats> stats = monitor->GetFlowStats ();
+  std::cout << "Chain of " << numNodes << " nodes, " << (fullDuplex ? "full" : "half") << " duplex\n";
+  for (std::map<FlowId, FlowMonitor::FlowStats>::const_iterator i = stats.begin (); i != stats.end (); ++i)
+    {
+      Ipv4FlowClassifier::FiveTuple t = classifier->FindFlow (i->first);
+      if (t.destinationPort != cbrPort)
+        {
+          continue;
+        }
+      std::cout << "  Flow " << t.sourceAddress << " -> " << t.destinationAddress << "\n";
+      std::cout << "  Tx Packets: " << i->second.txPackets << "\n";
+      std::cout << "  Rx Packets: " << i->second.rxPackets << "\n";
+      std::cout << "  Throughput: " << i->second.rxBytes * 8.0 / duration / 1e6 << " Mbps\n";
+      if (i->second.rxPackets > 0)
+        {
+          std::cout << "  Mean delay: " << (double) i->second.delaySum.GetMicroSeconds () / i->second.rxPackets << " us\n";
+        }
+    }
+  for (uint32_t i = 0; i + 1 < numNodes; ++i)
+    {
+      std::cout << "  Hop " << i << " -> " << i + 1 << ": " << hopRxPackets[i] << " packets, "
+                << hopRxBytes[i] * 8.0 / duration / 1e6 << " Mbps\n";
+    }
+
+  Simulator::Destroy ();
+  return 0;
+}
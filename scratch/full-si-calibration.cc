@@ -0,0 +1,313 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Residual self-interference calibration for full duplex radios.
+ *
+ * Sweeps tx power and channel bandwidth, computes the residual self
+ * interference left after cancellation and the SINR of the link from a
+ * full duplex peer at the given distance, and writes the residual SI
+ * table to a binary file. The residual SI comes from a parametric model
+ * (cancellation, knee and slopes given on the command line), not from
+ * measured hardware; measured values can be written in the same format.
+ *
+ * Table file layout (little endian, no padding):
+ *
+ *   char     magic[4]       "FDSI"
+ *   uint32_t version        1
+ *   uint32_t numPowers
+ *   uint32_t numBandwidths
+ *   double   powerStart     dBm
+ *   double   powerStep      dB
+ *   double   bandwidth[numBandwidths]   MHz
+ *   float    residualSi[numBandwidths][numPowers]   dBm
+ *
+ * The entries are dense and evenly spaced in tx power, so a reader that
+ * maps the file finds the entry for (bandwidth index, tx power) with one
+ * subtraction and one division, no search (see LookupSiTable).
+ *
+ *   ./waf --run "full-si-calibration --cancellation=110 --distance=50"
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/propagation-module.h"
+#include "ns3/mobility-module.h"
+
+#include <iostream>
+#include <fstream>
+#include <iterator>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cmath>
+
+NS_LOG_COMPONENT_DEFINE ("FullSiCalibration");
+
+using namespace ns3;
+
+static const uint32_t SI_TABLE_VERSION = 1;
+static const uint32_t SI_TABLE_HEADER_SIZE = 4 + 3 * 4 + 2 * 8;
+
+/// A residual SI table held in memory exactly as it is laid out on disk
+struct SiTable
+{
+  std::vector<uint8_t> buffer;
+  uint32_t numPowers;
+  uint32_t numBandwidths;
+  double powerStart;
+  double powerStep;
+  uint32_t dataOffset;   // offset of residualSi[0][0] in buffer
+};
+
+/// Thermal noise plus receiver noise figure over the given bandwidth, in dBm
+static double
+NoiseDbm (double bandwidthMhz, double noiseFigure)
+{
+  return -174.0 + 10.0 * std::log10 (bandwidthMhz * 1e6) + noiseFigure;
+}
+
+/**
+ * Residual SI (dBm) left after cancellation at the given tx power and
+ * bandwidth. Cancellation degrades above the knee (PA non-linearity) and
+ * for every doubling of the bandwidth over the narrowest swept channel.
+ */
+static double
+ResidualSiDbm (double txPowerDbm, double bandwidthMhz, double narrowestMhz, double cancellation,
+               double kneeDbm, double powerSlope, double bandwidthSlope)
+{
+  double sic = cancellation;
+  if (txPowerDbm > kneeDbm)
+    {
+      sic -= powerSlope * (txPowerDbm - kneeDbm);
+    }
+  sic -= bandwidthSlope * std::log (bandwidthMhz / narrowestMhz) / std::log (2.0);
+  return txPowerDbm - sic;
+}
+
+static void
+PutU32 (std::vector<uint8_t> &out, uint32_t value)
+{
+  for (uint32_t i = 0; i < 4; ++i)
+    {
+      out.push_back ((value >> (8 * i)) & 0xff);
+    }
+}
+
+static void
+PutU64 (std::vector<uint8_t> &out, uint64_t value)
+{
+  for (uint32_t i = 0; i < 8; ++i)
+    {
+      out.push_back ((value >> (8 * i)) & 0xff);
+    }
+}
+
+static void
+PutDouble (std::vector<uint8_t> &out, double value)
+{
+  uint64_t bits;
+  std::memcpy (&bits, &value, sizeof (bits));
+  PutU64 (out, bits);
+}
+
+static void
+PutFloat (std::vector<uint8_t> &out, float value)
+{
+  uint32_t bits;
+  std::memcpy (&bits, &value, sizeof (bits));
+  PutU32 (out, bits);
+}
+
+static uint32_t
+GetU32 (const std::vector<uint8_t> &in, uint32_t offset)
+{
+  uint32_t value = 0;
+  for (uint32_t i = 0; i < 4; ++i)
+    {
+      value |= (uint32_t) in[offset + i] << (8 * i);
+    }
+  return value;
+}
+
+static double
+GetDouble (const std::vector<uint8_t> &in, uint32_t offset)
+{
+  uint64_t bits = 0;
+  for (uint32_t i = 0; i < 8; ++i)
+    {
+      bits |= (uint64_t) in[offset + i] << (8 * i);
+    }
+  double value;
+  std::memcpy (&value, &bits, sizeof (value));
+  return value;
+}
+
+static void
+WriteSiTable (std::string fileName, double powerStart, double powerStep, uint32_t numPowers,
+              const std::vector<double> &bandwidths, const std::vector<float> &table)
+{
+  std::vector<uint8_t> out;
+  out.insert (out.end (), "FDSI", "FDSI" + 4);
+  PutU32 (out, SI_TABLE_VERSION);
+  PutU32 (out, numPowers);
+  PutU32 (out, bandwidths.size ());
+  PutDouble (out, powerStart);
+  PutDouble (out, powerStep);
+  for (uint32_t i = 0; i < bandwidths.size (); ++i)
+    {
+      PutDouble (out, bandwidths[i]);
+    }
+  for (uint32_t i = 0; i < table.size (); ++i)
+    {
+      PutFloat (out, table[i]);
+    }
+
+  std::ofstream file (fileName.c_str (), std::ios::out | std::ios::binary | std::ios::trunc);
+  file.write (reinterpret_cast<const char *> (&out[0]), out.size ());
+  file.close ();
+  NS_ABORT_MSG_IF (file.fail (), "could not write " << fileName);
+}
+
+static SiTable
+LoadSiTable (std::string fileName)
+{
+  SiTable table;
+  std::ifstream file (fileName.c_str (), std::ios::in | std::ios::binary);
+  NS_ABORT_MSG_IF (!file, "could not open " << fileName);
+  table.buffer.assign (std::istreambuf_iterator<char> (file), std::istreambuf_iterator<char> ());
+
+  NS_ABORT_MSG_IF (table.buffer.size () < SI_TABLE_HEADER_SIZE
+                   || std::memcmp (&table.buffer[0], "FDSI", 4) != 0,
+                   fileName << " is not a residual SI table");
+  NS_ABORT_MSG_IF (GetU32 (table.buffer, 4) != SI_TABLE_VERSION,
+                   fileName << " has unsupported version " << GetU32 (table.buffer, 4));
+  table.numPowers = GetU32 (table.buffer, 8);
+  table.numBandwidths = GetU32 (table.buffer, 12);
+  table.powerStart = GetDouble (table.buffer, 16);
+  table.powerStep = GetDouble (table.buffer, 24);
+  NS_ABORT_MSG_IF (table.numPowers == 0 || table.numBandwidths == 0,
+                   fileName << " has an empty dimension");
+  NS_ABORT_MSG_IF (!(table.powerStep > 0), fileName << " has a non-positive power step");
+  uint64_t dataOffset = SI_TABLE_HEADER_SIZE + (uint64_t) table.numBandwidths * 8;
+  NS_ABORT_MSG_IF (table.buffer.size () != dataOffset + (uint64_t) table.numBandwidths * table.numPowers * 4,
+                   fileName << " is truncated");
+  table.dataOffset = dataOffset;
+  return table;
+}
+
+/// Residual SI (dBm) at the entry nearest to txPowerDbm, clamped to the swept range
+static float
+LookupSiTable (const SiTable &table, uint32_t bandwidthIndex, double txPowerDbm)
+{
+  NS_ABORT_MSG_IF (bandwidthIndex >= table.numBandwidths,
+                   "bandwidth index " << bandwidthIndex << " out of " << table.numBandwidths);
+  double position = std::floor ((txPowerDbm - table.powerStart) / table.powerStep + 0.5);
+  uint32_t p = position < 0 ? 0 : std::min ((uint32_t) position, table.numPowers - 1);
+  uint32_t bits = GetU32 (table.buffer, table.dataOffset + (bandwidthIndex * table.numPowers + p) * 4);
+  float value;
+  std::memcpy (&value, &bits, sizeof (value));
+  return value;
+}
+
+int
+main (int argc, char *argv[])
+{
+  double powerStart = 0;      // dBm
+  double powerEnd = 20;       // dBm
+  double powerStep = 1;       // dB
+  double cancellation = 110;  // dB, total analog + digital
+  double knee = 15;           // dBm
+  double powerSlope = 1;      // dB of cancellation lost per dB above the knee
+  double bandwidthSlope = 3;  // dB of cancellation lost per bandwidth doubling
+  double noiseFigure = 7;     // dB, as in the hidden terminal scripts
+  double distance = 50;       // m, to the full duplex peer
+  std::string fileName = "full-si-table.bin";
+
+  CommandLine cmd;
+  cmd.AddValue ("powerStart", "first tx power of the sweep (dBm)", powerStart);
+  cmd.AddValue ("powerEnd", "last tx power of the sweep (dBm)", powerEnd);
+  cmd.AddValue ("powerStep", "tx power step (dB)", powerStep);
+  cmd.AddValue ("cancellation", "self-interference cancellation below the knee, 5 MHz channel (dB)", cancellation);
+  cmd.AddValue ("knee", "tx power above which cancellation degrades (dBm)", knee);
+  cmd.AddValue ("powerSlope", "cancellation lost per dB of tx power above the knee", powerSlope);
+  cmd.AddValue ("bandwidthSlope", "cancellation lost per doubling of bandwidth above 5 MHz", bandwidthSlope);
+  cmd.AddValue ("noiseFigure", "receiver noise figure (dB)", noiseFigure);
+  cmd.AddValue ("distance", "distance to the full duplex peer (m)", distance);
+  cmd.AddValue ("output", "name of the residual SI table file", fileName);
+  cmd.Parse (argc, argv);
+
+  NS_ABORT_MSG_IF (powerStep <= 0, "powerStep must be positive");
+  NS_ABORT_MSG_IF (powerEnd < powerStart, "powerEnd must not be below powerStart");
+  NS_ABORT_MSG_IF ((powerEnd - powerStart) / powerStep > 100000, "too many tx power steps");
+  NS_ABORT_MSG_IF (distance <= 0, "distance must be positive");
+
+  Ptr<FriisPropagationLossModel> lossModel = CreateObject<FriisPropagationLossModel> ();
+  lossModel->SetLambda (3.0e8/5.0e9);
+
+  Ptr<ConstantPositionMobilityModel> a = CreateObject<ConstantPositionMobilityModel> ();
+  Ptr<ConstantPositionMobilityModel> b = CreateObject<ConstantPositionMobilityModel> ();
+  a->SetPosition (Vector (0.0, 0.0, 0.0));
+  b->SetPosition (Vector (distance, 0.0, 0.0));
+
+  // 802.11a channel widths, narrowest first
+  std::vector<double> bandwidths;
+  bandwidths.push_back (5.0);
+  bandwidths.push_back (10.0);
+  bandwidths.push_back (20.0);
+
+  // never step past powerEnd; the epsilon only absorbs rounding error
+  uint32_t numPowers = (uint32_t) std::floor ((powerEnd - powerStart) / powerStep + 1e-9) + 1;
+  std::vector<float> table (bandwidths.size () * numPowers);
+
+  std::cout << "bandwidth(MHz) txPower(dBm) residualSi(dBm) noise(dBm) rxPower(dBm) sinr(dB)" << std::endl;
+  for (uint32_t bw = 0; bw < bandwidths.size (); ++bw)
+    {
+      double noise = NoiseDbm (bandwidths[bw], noiseFigure);
+      for (uint32_t p = 0; p < numPowers; ++p)
+        {
+          double txPower = powerStart + p * powerStep;
+          double si = ResidualSiDbm (txPower, bandwidths[bw], bandwidths[0], cancellation,
+                                     knee, powerSlope, bandwidthSlope);
+          // both ends of the self link use the same tx power
+          double rxPower = lossModel->CalcRxPower (txPower, a, b);
+          double interference = 10.0 * std::log10 (std::pow (10.0, noise / 10.0) + std::pow (10.0, si / 10.0));
+          double sinr = rxPower - interference;
+          table[bw * numPowers + p] = si;
+
+          std::cout << bandwidths[bw] << " " << txPower << " " << si << " "
+                    << noise << " " << rxPower << " " << sinr << std::endl;
+        }
+    }
+
+  WriteSiTable (fileName, powerStart, powerStep, numPowers, bandwidths, table);
+
+  // read the file back and check every entry through the lookup path
+  SiTable loaded = LoadSiTable (fileName);
+  NS_ABORT_MSG_IF (loaded.numPowers != numPowers || loaded.numBandwidths != bandwidths.size (),
+                   "table dimensions do not match after reading back " << fileName);
+  for (uint32_t bw = 0; bw < bandwidths.size (); ++bw)
+    {
+      for (uint32_t p = 0; p < numPowers; ++p)
+        {
+          float value = LookupSiTable (loaded, bw, powerStart + p * powerStep);
+          NS_ABORT_MSG_IF (value != table[bw * numPowers + p],
+                           "entry (" << bw << "," << p << ") differs after reading back " << fileName);
+        }
+    }
+  NS_LOG_UNCOND ("Wrote and verified " << table.size () << " entries in " << fileName);
+
+  return 0;
+}